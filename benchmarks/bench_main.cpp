@@ -4,6 +4,8 @@
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <utility>
+#include <vector>
 
 using namespace syncbone;
 namespace fs = std::filesystem;
@@ -83,10 +85,24 @@ int main(int argc, char** argv) {
     SyncOptions optDry; optDry.dry_run = true; auto rDry = run_once(src,"bench_dry_out", optDry);
     std::cout << "dry-run estimate: "<< rDry.seconds << "s would_copy="<<rDry.stats.files_copied << std::endl;
 
+    // Cost of each durability level (fresh destination each, same thread count as the first copy)
+    std::vector<std::pair<Durability, RunResult>> dur_runs;
+    for(Durability d : {Durability::none, Durability::batch, Durability::strict}) {
+        fs::path dst_d = std::string("bench_dst_durability_") + to_string(d); fs::remove_all(dst_d);
+        SyncOptions optD; optD.threads = 1; optD.durability = d;
+        auto r = run_once(src, dst_d, optD);
+        std::cout << "copy durability="<<to_string(d)<<" first: "<< r.seconds << "s copied="<<r.stats.files_copied
+                  << " throughput_MBps="<< total_mb / r.seconds << std::endl;
+        dur_runs.emplace_back(d, r);
+        fs::remove_all(dst_d);
+    }
+
     std::cout << "CSV: mode,threads,seconds,files_copied,files_skipped,throughput_MBps" << std::endl;
     std::cout << "CSV: first_copy,1,"<<r1.seconds<<","<<r1.stats.files_copied<<","<<r1.stats.files_skipped<<","<<mbps1<<"\n";
     std::cout << "CSV: resync,1,"<<r2.seconds<<","<<r2.stats.files_copied<<","<<r2.stats.files_skipped<<",0\n";
     std::cout << "CSV: first_copy,"<<threads_multi<<","<<r3.seconds<<","<<r3.stats.files_copied<<","<<r3.stats.files_skipped<<","<<mbpsT<<"\n";
     std::cout << "CSV: dry_run,0,"<<rDry.seconds<<","<<rDry.stats.files_copied<<","<<rDry.stats.files_skipped<<",0\n";
+    for(auto const &[d, r] : dur_runs)
+        std::cout << "CSV: durability_"<<to_string(d)<<",1,"<<r.seconds<<","<<r.stats.files_copied<<","<<r.stats.files_skipped<<","<<total_mb / r.seconds<<"\n";
     return 0;
 }
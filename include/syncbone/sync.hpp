@@ -10,6 +10,7 @@
 #pragma once
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 namespace syncbone {
@@ -24,14 +25,46 @@ struct SyncStats {
     std::uintmax_t files_skipped = 0; //!< Number of files skipped because they were identical
     std::uintmax_t dirs_created = 0;  //!< Number of subdirectories created
     std::uintmax_t errors = 0;        //!< Number of copy / directory creation failures encountered
+    std::uintmax_t files_resumed = 0; //!< Copies continued from a journal checkpoint instead of byte 0 (also in files_copied)
 };
 
+/**
+ * \brief How hard a sync run works to make copied files survive a crash or power loss.
+ * \details Every level writes to a temporary file next to the destination and publishes it
+ * with an atomic rename, so a reader never observes a truncated file. The levels differ only
+ * in when (and whether) data is flushed to stable storage:
+ *  - none:   rename only; data reaches the disk whenever the OS decides. The resume journal
+ *            then only keeps partial-copy checkpoints: finished files are re-checked by hash.
+ *  - batch:  temp files are flushed in groups (one syncfs on Linux, fdatasync per file elsewhere),
+ *            then renamed, then the touched directories are fsync'ed once each.
+ *  - strict: fdatasync + rename + directory fsync for every single file.
+ * With batch and strict, directories created by the run are also fsync'ed into their parents
+ * before any file is published into them.
+ */
+enum class Durability { none, batch, strict };
+
+/**
+ * \brief I/O scheduling class requested for the threads of a sync run.
+ * \details On Linux this maps to ioprio_set: best_effort = best-effort class at its lowest
+ * level (7), idle = idle class (only served when the device is otherwise unused). On Windows
+ * idle enters thread background mode and best_effort is a no-op. normal leaves priority untouched.
+ */
+enum class IoPriority { normal, best_effort, idle };
+
 /** \brief Options controlling synchronization behavior. */
 struct SyncOptions {
     bool dry_run = false;   //!< If true, do not modify filesystem; statistics show intended actions.
     bool verbose = false;   //!< If true, log per-file / per-directory actions (or intended actions in dry-run).
     unsigned threads = 1;   //!< >1 enables parallel file processing (hash + copy). 1 = sequential.
     bool color = false;     //!< Colorize console output (ANSI). Default off unless explicitly requested.
+    Durability durability = Durability::batch; //!< Flush policy for published files (see Durability).
+    std::uint64_t read_bps = 0;    //!< Read bandwidth limit in bytes/s shared by all workers (hashing + copy). 0 = unlimited.
+    std::uint64_t write_bps = 0;   //!< Write bandwidth limit in bytes/s shared by all workers. 0 = unlimited.
+    std::uint64_t iops = 0;        //!< Limit on read + write operations per second (one per chunk). 0 = unlimited.
+    IoPriority io_priority = IoPriority::normal; //!< I/O scheduling class for the run (see IoPriority).
+    unsigned latency_target_ms = 0; //!< If >0, copies flush written data every 4 MiB and at file end, and back off while the smoothed flush latency exceeds this.
+    bool resume = true;             //!< Keep a checkpoint journal in dest so an interrupted run can be resumed (ignored in dry-run; with Durability::none only partial copies resume).
+    std::uint64_t checkpoint_bytes = 64ULL << 20; //!< Files larger than this record a resumable offset every checkpoint_bytes. 0 = off.
 };
 
 /**
@@ -50,6 +83,40 @@ std::string sha256_file(const fs::path &p);
  */
 bool should_copy_file(const fs::path &src, const fs::path &dst);
 
+/**
+ * \brief Copy src to dst via a temporary file in dst's directory and an atomic rename.
+ * \param durability Flush policy; batch behaves like strict for a single file.
+ * \return true on success. On failure dst is left untouched and the temporary file is removed.
+ */
+bool copy_file_atomic(const fs::path &src, const fs::path &dst, Durability durability = Durability::strict);
+
+/**
+ * \brief Single-file copy honoring the durability, I/O limit and I/O priority fields of options.
+ * \details Other fields (threads, resume, verbose, ...) do not apply to a single file and are ignored.
+ */
+bool copy_file_atomic(const fs::path &src, const fs::path &dst, const SyncOptions &options);
+
+/**
+ * \brief Parse a durability level name ("none", "batch" or "strict").
+ * \return false if the name is unknown (out is left unchanged).
+ */
+bool parse_durability(std::string_view v, Durability &out);
+
+/** \brief Name of a durability level, inverse of parse_durability. */
+const char* to_string(Durability d);
+
+/**
+ * \brief Parse a byte rate such as "500K", "20M" or "1G" (binary multiples, optional trailing "B" or "/s").
+ * \return false on malformed input (out is left unchanged).
+ */
+bool parse_rate(std::string_view v, std::uint64_t &out);
+
+/**
+ * \brief Parse an I/O priority name ("normal", "best-effort" or "idle").
+ * \return false if the name is unknown (out is left unchanged).
+ */
+bool parse_io_priority(std::string_view v, IoPriority &out);
+
 /**
  * \brief Recursively perform a one-way synchronization of directories.
  * \param source Source directory (must exist).
@@ -57,6 +124,10 @@ bool should_copy_file(const fs::path &src, const fs::path &dst);
  * \param stats Statistics accumulator to update.
  * \param dry_run If true, no filesystem changes are performed; statistics reflect what WOULD happen.
  * \note Files that exist only in dest are not deleted (no pruning).
+ * \note With SyncOptions::resume a ".syncbone.journal" file is kept in dest while the run is in
+ *       progress. If the run is interrupted, the next run skips files the journal lists as done
+ *       (source size and mtime unchanged, no re-hashing) and continues large copies from their
+ *       last checkpoint. The journal is removed when a run completes without errors.
  */
 // Legacy convenience overload (kept for compatibility)
 void sync_directory(const fs::path &source, const fs::path &dest, SyncStats &stats, bool dry_run = false);
@@ -0,0 +1,243 @@
+#include "durable.hpp"
+#include "throttle.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <system_error>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace syncbone::detail {
+
+static const fs::path::string_type tmp_suffix = fs::path(".sbtmp").native();
+static constexpr std::size_t name_max = 255; // NAME_MAX on Linux/macOS, path component limit on NTFS
+
+fs::path temp_path_for(const fs::path &dst) {
+    auto name = dst.filename().native();
+    if(1 + name.size() + tmp_suffix.size() <= name_max)
+        return dst.parent_path() / (fs::path(".").native() + name + tmp_suffix);
+    // FNV-1a over the name's code units: short, bounded and stable across runs
+    std::uint64_t h = 1469598103934665603ULL;
+    for(auto c : name) { h ^= static_cast<std::uint64_t>(c); h *= 1099511628211ULL; }
+    static const char* hexd = "0123456789abcdef";
+    std::string hashed = ".sb-";
+    for(int i=60;i>=0;i-=4) hashed.push_back(hexd[(h>>i)&0xF]);
+    return dst.parent_path() / (fs::path(hashed).native() + tmp_suffix);
+}
+
+bool is_temp_name(const fs::path &name) {
+    auto n = name.native();
+    return n.size() > tmp_suffix.size() && n.front() == '.' && n.ends_with(tmp_suffix);
+}
+
+bool flush_file(const fs::path &p) {
+#ifdef _WIN32
+    int fd = _wopen(p.c_str(), _O_RDWR | _O_BINARY);
+    if(fd < 0) return false;
+    bool ok = _commit(fd) == 0;
+    _close(fd);
+    return ok;
+#else
+    int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+#if defined(__APPLE__)
+    bool ok = ::fsync(fd) == 0;
+#else
+    bool ok = ::fdatasync(fd) == 0;
+#endif
+    ::close(fd);
+    return ok;
+#endif
+}
+
+bool flush_dir(const fs::path &dir) {
+#ifdef _WIN32
+    (void)dir; return true; // NTFS journals renames; directory handles cannot be flushed portably
+#else
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+static bool copy_chunked(const fs::path &src, const fs::path &tmp, const CopyPlan &plan) {
+    using clock = std::chrono::steady_clock;
+    std::error_code ec;
+    std::ifstream in(src, std::ios::binary);
+    if(!in) return false;
+    std::ofstream out;
+    if(plan.resume_from > 0) {
+        // Drop anything written after the last checkpoint, then continue from there
+        fs::resize_file(tmp, plan.resume_from, ec); if(ec) return false;
+        out.open(tmp, std::ios::binary | std::ios::in | std::ios::out);
+        in.seekg(static_cast<std::streamoff>(plan.resume_from));
+        out.seekp(static_cast<std::streamoff>(plan.resume_from));
+    } else {
+        // A stale temp may already carry a read-only source mode; replace rather than truncate it
+        fs::remove(tmp, ec);
+        out.open(tmp, std::ios::binary | std::ios::trunc);
+    }
+    if(!in || !out) return false;
+    IoThrottle *throttle = plan.throttle && plan.throttle->active() ? plan.throttle : nullptr;
+    bool probe = throttle && throttle->probes_latency();
+    std::uint64_t offset = plan.resume_from, next_checkpoint = offset + plan.checkpoint_bytes, unprobed = 0;
+    // Time a data flush: unlike buffered writes it waits for the device
+    auto probe_latency = [&]{
+        out.flush();
+        auto t0 = clock::now();
+        flush_file(tmp);
+        throttle->record_latency(clock::now() - t0);
+        unprobed = 0;
+    };
+    std::vector<char> buf(256 * 1024);
+    while(in) {
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        std::streamsize got = in.gcount();
+        if(got <= 0) break; // the empty read at EOF costs neither bytes nor an operation
+        if(throttle) throttle->after_read(static_cast<std::size_t>(got));
+        if(throttle) throttle->before_write(static_cast<std::size_t>(got));
+        out.write(buf.data(), got);
+        if(!out) return false;
+        offset += static_cast<std::uint64_t>(got);
+        unprobed += static_cast<std::uint64_t>(got);
+        if(probe && unprobed >= IoThrottle::latency_probe_bytes) probe_latency();
+        if(plan.on_checkpoint && plan.checkpoint_bytes > 0 && offset >= next_checkpoint) {
+            out.flush();
+            if(out && flush_file(tmp)) plan.on_checkpoint(offset);
+            next_checkpoint = offset + plan.checkpoint_bytes;
+        }
+    }
+    if(in.bad()) return false;
+    if(probe && unprobed > 0) probe_latency();
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+bool resume_point_valid(const fs::path &src, const fs::path &tmp, std::uint64_t offset) {
+    std::error_code ec;
+    auto tmp_size = fs::file_size(tmp, ec);
+    if(ec || tmp_size < offset || offset == 0) return false;
+    std::uint64_t window = std::min<std::uint64_t>(offset, 64 * 1024);
+    std::vector<char> a(window), b(window);
+    std::ifstream sa(src, std::ios::binary), sb(tmp, std::ios::binary);
+    sa.seekg(static_cast<std::streamoff>(offset - window)); sb.seekg(static_cast<std::streamoff>(offset - window));
+    sa.read(a.data(), static_cast<std::streamsize>(window)); sb.read(b.data(), static_cast<std::streamsize>(window));
+    return sa && sb && a == b;
+}
+
+// Stream copies create tmp with umask-default mode; carry the source mode over like fs::copy_file does
+static bool copy_permissions(const fs::path &src, const fs::path &tmp) {
+    std::error_code ec;
+    auto st = fs::status(src, ec); if(ec) return false;
+    fs::permissions(tmp, st.permissions(), fs::perm_options::replace, ec);
+    return !ec;
+}
+
+bool copy_to_temp(const fs::path &src, const fs::path &tmp, const CopyPlan &plan) {
+    bool chunked = (plan.throttle && plan.throttle->active()) || plan.resume_from > 0 || (plan.on_checkpoint && plan.checkpoint_bytes > 0);
+    if(chunked) {
+        if(copy_chunked(src, tmp, plan) && copy_permissions(src, tmp)) return true;
+        std::error_code rm_ec; fs::remove(tmp, rm_ec);
+        return false;
+    }
+    std::error_code ec;
+    fs::copy_file(src, tmp, fs::copy_options::overwrite_existing, ec);
+    if(!ec) return true;
+    // Fallback path: remove and copy manually (handles sporadic overwrite issues on some Windows runners)
+    std::error_code rm_ec; fs::remove(tmp, rm_ec);
+    bool ok = false;
+    {
+        std::ifstream in(src, std::ios::binary);
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if(in && out) { out << in.rdbuf(); out.flush(); ok = static_cast<bool>(out); }
+    }
+    ok = ok && copy_permissions(src, tmp);
+    if(!ok) fs::remove(tmp, rm_ec);
+    return ok;
+}
+
+static bool rename_over(const fs::path &tmp, const fs::path &dst) {
+    std::error_code ec; fs::rename(tmp, dst, ec);
+    if(!ec) return true;
+    std::cerr << "WARN: cannot publish "<<dst<<": "<<ec.message()<<"\n";
+    std::error_code rm_ec; fs::remove(tmp, rm_ec);
+    return false;
+}
+
+bool PublishQueue::publish(const fs::path &tmp, const fs::path &dst, const std::string &key, const FileStamp *stamp) {
+    bool journaled = journal_ && stamp;
+    switch(durability_) {
+    case Durability::none:
+        return rename_over(tmp, dst); // nothing is durable, so no done record (see sync_directory)
+    case Durability::strict:
+        if(!flush_file(tmp)) { std::error_code rm_ec; fs::remove(tmp, rm_ec); return false; }
+        if(!rename_over(tmp, dst) || !flush_dir(dst.parent_path())) return false;
+        if(journaled) journal_->record_done(key, *stamp);
+        return true;
+    case Durability::batch:
+        break;
+    }
+    std::lock_guard<std::mutex> lk(mutex_);
+    pending_.push_back({tmp, dst, key, stamp ? *stamp : FileStamp{}, journaled});
+    if(pending_.size() >= batch_limit_) flush_locked();
+    return true;
+}
+
+void PublishQueue::flush_locked() {
+    if(pending_.empty()) return;
+    // 1) data: one syncfs per filesystem on Linux, otherwise one fdatasync per staged file
+#if defined(__linux__)
+    std::set<dev_t> synced;
+    for(auto const &p : pending_) {
+        struct stat st{};
+        fs::path dir = p.tmp.parent_path();
+        if(::stat(dir.empty() ? "." : dir.c_str(), &st) != 0 || synced.count(st.st_dev)) continue;
+        int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(fd < 0) continue;
+        if(::syncfs(fd) == 0) synced.insert(st.st_dev);
+        ::close(fd);
+    }
+    // A failed syncfs leaves its device out of the set; fall back to per-file flushes there.
+    auto data_synced = [&](const fs::path &tmp){
+        struct stat st{};
+        return ::stat(tmp.c_str(), &st) == 0 && synced.count(st.st_dev) ? true : flush_file(tmp);
+    };
+#else
+    auto data_synced = [](const fs::path &tmp){ return flush_file(tmp); };
+#endif
+    // 2) publish, 3) persist the directory entries
+    std::set<fs::path> dirs;
+    std::vector<const Pending*> published;
+    for(auto const &p : pending_) {
+        if(!data_synced(p.tmp)) {
+            std::cerr << "WARN: cannot flush "<<p.tmp<<"\n";
+            std::error_code rm_ec; fs::remove(p.tmp, rm_ec); ++failed_; continue;
+        }
+        if(rename_over(p.tmp, p.dst)) { dirs.insert(p.dst.parent_path()); published.push_back(&p); } else ++failed_;
+    }
+    for(auto const &d : dirs) flush_dir(d);
+    // 4) only now are the files durable: checkpoint them with a single journal flush
+    if(journal_) {
+        for(auto const *p : published) if(p->journaled) journal_->record_done(p->key, p->stamp);
+        journal_->sync();
+    }
+    pending_.clear();
+}
+
+std::uintmax_t PublishQueue::finish() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    flush_locked();
+    return failed_;
+}
+
+} // namespace syncbone::detail
@@ -0,0 +1,82 @@
+/**
+ * \file durable.hpp
+ * \brief Internal helpers for crash-safe publishing of copied files (temp file + rename).
+ */
+#pragma once
+#include "syncbone/sync.hpp"
+#include "journal.hpp"
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace syncbone::detail {
+
+/**
+ * \brief Temporary sibling used while dst is being written (".<name>.sbtmp").
+ * \details Names that would exceed the 255 unit filename limit use ".sb-<64-bit hash of name>.sbtmp"
+ * instead; the mapping is deterministic so an interrupted copy can still be resumed.
+ */
+fs::path temp_path_for(const fs::path &dst);
+
+/** \brief True if a file name matches either temp_path_for() scheme. */
+bool is_temp_name(const fs::path &name);
+
+/** \brief Flush file data (not necessarily metadata) of an existing file. */
+bool flush_file(const fs::path &p);
+
+/** \brief Flush a directory so that renames inside it are persisted. No-op on Windows. */
+bool flush_dir(const fs::path &dir);
+
+class IoThrottle;
+
+/**
+ * \brief How copy_to_temp moves the bytes.
+ * \details The whole file is handed to the OS copy routine unless a chunked copy is needed:
+ * an active throttle, a resume offset or a checkpoint callback.
+ */
+struct CopyPlan {
+    IoThrottle *throttle = nullptr;        //!< Meter every chunk (see IoThrottle).
+    std::uint64_t resume_from = 0;         //!< Keep the first resume_from bytes already in tmp.
+    std::uint64_t checkpoint_bytes = 0;    //!< Flush tmp and call on_checkpoint every this many bytes.
+    std::function<void(std::uint64_t)> on_checkpoint; //!< Receives the flushed offset.
+};
+
+/** \brief Copy src into tmp (overwriting any stale leftover). Removes tmp on failure. */
+bool copy_to_temp(const fs::path &src, const fs::path &tmp, const CopyPlan &plan = {});
+
+/**
+ * \brief Check that tmp can be resumed at offset: it is long enough and the last
+ * (up to 64 KiB) bytes before offset match src.
+ */
+bool resume_point_valid(const fs::path &src, const fs::path &tmp, std::uint64_t offset);
+
+/**
+ * \brief Publishes staged temp files according to a Durability level.
+ * \details publish() is thread-safe. With Durability::batch renames are deferred and
+ * performed in groups of up to batch_limit files; call finish() once all workers are
+ * done to publish the remainder. Deferred failures are reported by finish().
+ */
+class PublishQueue {
+public:
+    explicit PublishQueue(Durability d, Journal *journal = nullptr, std::size_t batch_limit = 256)
+        : durability_(d), journal_(journal), batch_limit_(batch_limit) {}
+    /**
+     * \brief Publish tmp as dst. Returns false only for immediate (none/strict) failures.
+     * \param key, stamp If a journal is attached, a done record is appended once dst is durable.
+     */
+    bool publish(const fs::path &tmp, const fs::path &dst, const std::string &key = {}, const FileStamp *stamp = nullptr);
+    /** \brief Flush outstanding batch; returns the number of files that could not be published. */
+    std::uintmax_t finish();
+private:
+    struct Pending { fs::path tmp, dst; std::string key; FileStamp stamp; bool journaled = false; };
+    void flush_locked();
+    Durability durability_;
+    Journal *journal_;
+    std::size_t batch_limit_;
+    std::mutex mutex_;
+    std::vector<Pending> pending_;
+    std::uintmax_t failed_ = 0;
+};
+
+} // namespace syncbone::detail
@@ -0,0 +1,103 @@
+#include "journal.hpp"
+#include "durable.hpp"
+#include <sstream>
+#include <system_error>
+
+namespace syncbone::detail {
+
+bool stamp_of(const fs::path &p, FileStamp &out) {
+    std::error_code ec;
+    auto size = fs::file_size(p, ec); if(ec) return false;
+    auto mtime = fs::last_write_time(p, ec); if(ec) return false;
+    out.size = size;
+    out.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+std::string journal_key(const fs::path &rel) {
+    auto u8 = rel.generic_u8string();
+    return std::string(u8.begin(), u8.end());
+}
+
+Journal::Journal(const fs::path &dest, const fs::path &source, bool sync_each)
+    : path_(dest / file_name), sync_each_(sync_each) {
+    std::error_code ec;
+    // Same tree regardless of spelling: "src", "./src/" and symlinked paths map to one header
+    fs::path root = fs::weakly_canonical(source, ec);
+    if(ec) root = fs::absolute(source, ec).lexically_normal();
+    while(root.has_relative_path() && root.filename().empty()) root = root.parent_path();
+    std::string header = "SBJ1 " + journal_key(root);
+    if(load(header)) {
+        // Cut a torn trailing record off so the next append starts on a fresh line
+        auto size = fs::file_size(path_, ec);
+        if(!ec && size > valid_bytes_) fs::resize_file(path_, valid_bytes_, ec);
+        out_.open(path_, std::ios::binary | std::ios::app);
+    } else {
+        entries_.clear();
+        out_.open(path_, std::ios::binary | std::ios::trunc);
+        append(header + "\n", true);
+    }
+}
+
+bool Journal::load(const std::string &header) {
+    std::ifstream in(path_, std::ios::binary);
+    if(!in) return false;
+    std::string line;
+    if(!std::getline(in, line) || in.eof() || line != header) return false;
+    valid_bytes_ = static_cast<std::uintmax_t>(in.tellg());
+    while(std::getline(in, line)) {
+        if(in.eof()) break; // no trailing newline: torn write from a crash
+        valid_bytes_ = static_cast<std::uintmax_t>(in.tellg());
+        std::istringstream ls(line);
+        char kind = 0; Entry e; ls >> kind >> e.stamp.size >> e.stamp.mtime;
+        if(kind == 'P') ls >> e.offset; else if(kind == 'D') e.done = true; else continue;
+        if(!ls || ls.get() != ' ') continue;
+        std::string key; std::getline(ls, key);
+        if(!key.empty()) entries_[key] = e;
+    }
+    return true;
+}
+
+bool Journal::is_done(const std::string &key, const FileStamp &st) const {
+    auto it = entries_.find(key);
+    return it != entries_.end() && it->second.done && it->second.stamp == st;
+}
+
+std::uint64_t Journal::partial_offset(const std::string &key, const FileStamp &st) const {
+    auto it = entries_.find(key);
+    if(it == entries_.end() || it->second.done || !(it->second.stamp == st)) return 0;
+    return it->second.offset;
+}
+
+void Journal::append(const std::string &line, bool force_sync) {
+    if(!out_.is_open()) return;
+    out_ << line; out_.flush();
+    if(force_sync || sync_each_) flush_file(path_);
+}
+
+void Journal::record_done(const std::string &key, const FileStamp &st) {
+    if(key.find('\n') != std::string::npos) return; // not representable; file is simply re-checked next time
+    std::ostringstream os; os << "D " << st.size << ' ' << st.mtime << ' ' << key << '\n';
+    std::lock_guard<std::mutex> lk(mutex_);
+    append(os.str(), false);
+}
+
+void Journal::record_partial(const std::string &key, const FileStamp &st, std::uint64_t offset) {
+    if(key.find('\n') != std::string::npos) return;
+    std::ostringstream os; os << "P " << st.size << ' ' << st.mtime << ' ' << offset << ' ' << key << '\n';
+    std::lock_guard<std::mutex> lk(mutex_);
+    append(os.str(), true);
+}
+
+void Journal::sync() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if(out_.is_open()) flush_file(path_);
+}
+
+void Journal::remove() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    out_.close();
+    std::error_code ec; fs::remove(path_, ec);
+}
+
+} // namespace syncbone::detail
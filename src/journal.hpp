@@ -0,0 +1,68 @@
+/**
+ * \file journal.hpp
+ * \brief Internal append-only checkpoint journal used to resume interrupted syncs.
+ *
+ * The journal lives in the destination root (".syncbone.journal") and holds one record per line:
+ *  - header  "SBJ1 <source>"                  ties the journal to one source tree
+ *  - done    "D <size> <mtime> <rel>"         file published (or verified identical)
+ *  - partial "P <size> <mtime> <offset> <rel>" first offset bytes of the temp file are flushed
+ * size/mtime are the source stat tuple at the time of the record; a record only applies while
+ * the source still has the same tuple. The last record for a path wins and a torn trailing line
+ * is ignored. A run that finishes without errors deletes the journal.
+ */
+#pragma once
+#include "syncbone/sync.hpp"
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace syncbone::detail {
+
+/** \brief Source stat tuple used to decide whether a journal record is still valid. */
+struct FileStamp {
+    std::uintmax_t size = 0;
+    std::int64_t mtime = 0;
+    bool operator==(const FileStamp&) const = default;
+};
+
+/** \brief Read the stat tuple of p. Returns false if p cannot be stat'ed. */
+bool stamp_of(const fs::path &p, FileStamp &out);
+
+/** \brief Journal key of a path relative to the sync roots (generic UTF-8 form). */
+std::string journal_key(const fs::path &rel);
+
+class Journal {
+public:
+    static constexpr const char* file_name = ".syncbone.journal";
+    /**
+     * \brief Load the journal in dest (if it belongs to source) and open it for appending.
+     * \details dest must already exist; otherwise the journal is disabled.
+     * \param sync_each If true every record is flushed to disk before returning (strict durability).
+     */
+    Journal(const fs::path &dest, const fs::path &source, bool sync_each);
+    /** \brief True if journal could not be opened; the run proceeds without checkpoints. */
+    bool disabled() const { return !out_.is_open(); }
+    /** \brief Source with this stamp was completely synced by an earlier, interrupted run. */
+    bool is_done(const std::string &key, const FileStamp &st) const;
+    /** \brief Flushed offset of an interrupted copy of this source version (0 if none). */
+    std::uint64_t partial_offset(const std::string &key, const FileStamp &st) const;
+    void record_done(const std::string &key, const FileStamp &st);
+    /** \brief Always flushed: callers must have flushed the temp file up to offset first. */
+    void record_partial(const std::string &key, const FileStamp &st, std::uint64_t offset);
+    /** \brief Flush all records appended so far to stable storage. */
+    void sync();
+    /** \brief Delete the journal after a clean run. */
+    void remove();
+private:
+    struct Entry { FileStamp stamp; bool done = false; std::uint64_t offset = 0; };
+    bool load(const std::string &header);
+    void append(const std::string &line, bool force_sync);
+    fs::path path_;
+    bool sync_each_;
+    std::unordered_map<std::string, Entry> entries_; //!< Read-only after construction
+    std::uintmax_t valid_bytes_ = 0; //!< End of the last complete line found by load()
+    std::mutex mutex_;
+    std::ofstream out_;
+};
+
+} // namespace syncbone::detail
@@ -1,4 +1,5 @@
 // main.cpp - CLI entry for SyncBone
+#include <charconv>
 #include <iostream>
 #include <filesystem>
 #include <string_view>
@@ -19,6 +20,14 @@ int main(int argc, char* argv[]) {
                      "  --threads N          Parallel file hashing/copy (N>0, 0=auto)\n"
                      "  --color|-c           Colorize output\n"
                      "  --no-color           Disable color if previously enabled\n"
+                     "  --durability=LEVEL   none|batch|strict flush policy for copied files (default batch)\n"
+                     "  --read-limit RATE    Max read bandwidth across all threads (e.g. 50M, 512K; bytes/s)\n"
+                     "  --write-limit RATE   Max write bandwidth across all threads\n"
+                     "  --iops N             Max read+write operations per second across all threads\n"
+                     "  --ioprio CLASS       I/O priority: normal|best-effort|idle\n"
+                     "  --latency-target MS  Back off while write flush latency (probed every 4 MiB copied) exceeds MS\n"
+                     "  --checkpoint SIZE    Record resumable progress every SIZE bytes of large files (default 64M, 0=off)\n"
+                     "  --no-resume          Do not keep a checkpoint journal in the destination\n"
                      "Exit codes:\n"
                      "  0 success\n"
                      "  1 usage / argument error\n"
@@ -33,6 +42,8 @@ int main(int argc, char* argv[]) {
     bool verbose = false;
     unsigned threads = 1;
     bool color = false;
+    syncbone::Durability durability = syncbone::Durability::batch;
+    syncbone::SyncOptions limits; // only the I/O limit / journal fields are filled from the CLI
     fs::path source;
     fs::path dest;
     for(int i=1;i<argc;++i){
@@ -48,6 +59,45 @@ int main(int argc, char* argv[]) {
         }
         if(a == "--color" || a == "-c") { color = true; continue; }
         if(a == "--no-color") { color = false; continue; }
+        // Options taking a value accept both "--name value" and "--name=value"
+        auto value_of = [&](std::string_view name, std::string_view &val) -> bool {
+            if(a == name) { if(i+1<argc) val = argv[++i]; return true; }
+            if(a.size() > name.size() && a.starts_with(name) && a[name.size()] == '=') { val = a.substr(name.size()+1); return true; }
+            return false;
+        };
+        std::string_view val;
+        if(value_of("--durability", val)) {
+            if(!syncbone::parse_durability(val, durability)) { std::cerr << "ERROR: durability must be none, batch or strict"<<"\n"; return 1; }
+            continue;
+        }
+        if(value_of("--read-limit", val)) {
+            if(!syncbone::parse_rate(val, limits.read_bps)) { std::cerr << "ERROR: invalid read limit"<<"\n"; return 1; }
+            continue;
+        }
+        if(value_of("--write-limit", val)) {
+            if(!syncbone::parse_rate(val, limits.write_bps)) { std::cerr << "ERROR: invalid write limit"<<"\n"; return 1; }
+            continue;
+        }
+        if(value_of("--iops", val)) {
+            // Plain operation count: no byte suffixes
+            auto [end, err] = std::from_chars(val.data(), val.data() + val.size(), limits.iops);
+            if(val.empty() || err != std::errc() || end != val.data() + val.size()) { std::cerr << "ERROR: invalid iops value"<<"\n"; return 1; }
+            continue;
+        }
+        if(value_of("--ioprio", val)) {
+            if(!syncbone::parse_io_priority(val, limits.io_priority)) { std::cerr << "ERROR: ioprio must be normal, best-effort or idle"<<"\n"; return 1; }
+            continue;
+        }
+        if(value_of("--checkpoint", val)) {
+            if(!syncbone::parse_rate(val, limits.checkpoint_bytes)) { std::cerr << "ERROR: invalid checkpoint size"<<"\n"; return 1; }
+            continue;
+        }
+        if(a == "--no-resume") { limits.resume = false; continue; }
+        if(value_of("--latency-target", val)) {
+            try { int ms = std::stoi(std::string(val)); if(ms<0){ std::cerr << "ERROR: latency target must be >=0"<<"\n"; return 1;} limits.latency_target_ms = static_cast<unsigned>(ms); }
+            catch(...) { std::cerr << "ERROR: invalid latency target"<<"\n"; return 1; }
+            continue;
+        }
         if(source.empty()) source = strip_quotes(argv[i]);
         else if(dest.empty()) dest = strip_quotes(argv[i]);
         else {
@@ -74,7 +124,7 @@ int main(int argc, char* argv[]) {
                               << " (" << ec.message() << ")\n"; return 3;
                 }
             }
-            syncbone::SyncOptions opts; opts.dry_run=dry_run; opts.verbose=verbose; opts.threads=threads; opts.color=color;
+            syncbone::SyncOptions opts = limits; opts.dry_run=dry_run; opts.verbose=verbose; opts.threads=threads; opts.color=color; opts.durability=durability;
             SyncStats stats; sync_directory(source, dest, stats, opts);
             const char* C_RESET = (color?"\x1b[0m":"");
             const char* C_HDR   = (color?"\x1b[1m":"");
@@ -102,8 +152,8 @@ int main(int argc, char* argv[]) {
                               << " (" << ec.message() << ")\n"; return 3;
                 }
             }
-            std::error_code ec; fs::copy_file(source, dest, fs::copy_options::overwrite_existing, ec);
-            if (ec) { std::cerr << "ERROR: failed to copy file: " << ec.message() << "\n"; return 4; }
+            syncbone::SyncOptions opts = limits; opts.durability = durability;
+            if (!syncbone::copy_file_atomic(source, dest, opts)) { std::cerr << "ERROR: failed to copy file: " << source << " -> " << dest << "\n"; return 4; }
             std::cout << "Copied file " << source << " -> " << dest << "\n";
         }
     } catch(const std::exception &e) {
@@ -1,5 +1,10 @@
 #include "syncbone/sync.hpp"
+#include "durable.hpp"
+#include "throttle.hpp"
+#include "journal.hpp"
 #include <array>
+#include <charconv>
+#include <limits>
 #include <fstream>
 #include <system_error>
 #include <cstring>
@@ -9,6 +14,8 @@
 #include <mutex>
 #include <vector>
 #include <algorithm>
+#include <optional>
+#include <set>
 
 namespace syncbone {
 namespace fs = std::filesystem;
@@ -98,18 +105,42 @@ std::string sha256_file(const fs::path &p) {
     return sha256_impl::hex(digest);
 }
 
-bool should_copy_file(const fs::path &src, const fs::path &dst) {
+// Metered variant: larger chunks so each read is charged once against the IOPS budget
+static std::string sha256_file_throttled(const fs::path &p, detail::IoThrottle &throttle) {
+    std::ifstream in(p, std::ios::binary);
+    if(!in) return {};
+    sha256_impl::Ctx ctx; std::vector<unsigned char> buf(256*1024);
+    while(in){
+        in.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        std::streamsize got=in.gcount();
+        if(got<=0) break;
+        throttle.after_read(static_cast<size_t>(got)); // charge what was read, not the buffer size
+        sha256_impl::update(ctx, buf.data(), static_cast<size_t>(got));
+    }
+    unsigned char digest[32]; sha256_impl::finalize(ctx,digest);
+    return sha256_impl::hex(digest);
+}
+
+static std::string hash_for_compare(const fs::path &p, detail::IoThrottle *throttle) {
+    return throttle && throttle->active() ? sha256_file_throttled(p, *throttle) : sha256_file(p);
+}
+
+static bool should_copy_file(const fs::path &src, const fs::path &dst, detail::IoThrottle *throttle) {
     std::error_code ec;
     if(!fs::exists(dst, ec)) return true;
     if(ec) return true;
     auto src_size = fs::file_size(src, ec); if(ec) return true;
     auto dst_size = fs::file_size(dst, ec); if(ec) return true;
     if(src_size != dst_size) return true;
-    auto h1 = sha256_file(src); auto h2 = sha256_file(dst);
+    auto h1 = hash_for_compare(src, throttle); auto h2 = hash_for_compare(dst, throttle);
     if(h1.empty() || h2.empty()) return true;
     return h1 != h2;
 }
 
+bool should_copy_file(const fs::path &src, const fs::path &dst) {
+    return should_copy_file(src, dst, nullptr);
+}
+
 void sync_directory(const fs::path &source, const fs::path &dest, SyncStats &stats, const SyncOptions &options) {
     bool dry_run = options.dry_run;
     // ANSI color helpers (enabled only if options.color=true). Keep simple to avoid overhead.
@@ -118,31 +149,74 @@ void sync_directory(const fs::path &source, const fs::path &dest, SyncStats &sta
     const char* C_SKIP  = options.color ? "\x1b[33m" : ""; // yellow
     const char* C_MKDIR = options.color ? "\x1b[36m" : ""; // cyan
     const char* C_DRY   = options.color ? "\x1b[35m" : ""; // magenta prefix
-    // Helper that tries std::filesystem first, then falls back to manual stream copy if needed
-    auto copy_file_force = [](const fs::path &src, const fs::path &dst) -> bool {
-        std::error_code ec;
-        fs::copy_file(src, dst, fs::copy_options::overwrite_existing, ec);
-        if(!ec) return true;
-        // Fallback path: remove and copy manually (handles sporadic overwrite issues on some Windows runners)
-        std::error_code rm_ec; fs::remove(dst, rm_ec);
-        std::ifstream in(src, std::ios::binary);
-        if(!in) return false;
-        std::ofstream out(dst, std::ios::binary | std::ios::trunc);
-        if(!out) return false;
-        out << in.rdbuf();
-        return static_cast<bool>(out);
-    };
     // Collect entries first for potential parallel processing
     std::vector<fs::path> dirs; dirs.reserve(128);
     std::vector<fs::path> files; files.reserve(256);
+    // Names that map onto SyncBone's own bookkeeping in dest: the root journal and staging temps
+    auto reserved_name = [&](const fs::path &p) {
+        if(detail::is_temp_name(p.filename())) return true;
+        return p.lexically_relative(source) == fs::path(detail::Journal::file_name);
+    };
     for(auto const &entry : fs::recursive_directory_iterator(source)) {
         if(entry.is_directory()) dirs.push_back(entry.path());
+        else if(entry.is_regular_file() && reserved_name(entry.path())) { if(options.verbose) std::cerr << "Skipping (reserved name): "<< entry.path() << "\n"; }
         else if(entry.is_regular_file()) files.push_back(entry.path());
         else if(options.verbose) std::cerr << "Skipping: "<< entry.path() << "\n";
     }
     // Sort directories by path length (shorter first) to ensure parent before child
     std::sort(dirs.begin(), dirs.end(), [](auto const &a, auto const &b){ return a.generic_string().size() < b.generic_string().size(); });
+    // Checkpoint journal in dest: lets an interrupted run skip finished files and resume large copies.
+    // Only set up once the source walk succeeded, so a bad source leaves dest untouched.
+    std::optional<detail::Journal> journal;
+    if(options.resume && !dry_run) {
+        std::error_code ec; fs::create_directories(dest, ec);
+        journal.emplace(dest, source, options.durability == Durability::strict);
+        if(journal->disabled()) journal.reset();
+    }
+    const std::uintmax_t errors_before = stats.errors;
+    // Files are staged under a temp name next to dst and published by rename (see Durability)
+    detail::PublishQueue publisher(options.durability, journal ? &*journal : nullptr);
+    // One throttle for the whole run so limits hold across all workers
+    detail::IoThrottle throttle(options);
+    detail::ScopedIoPriority io_priority(options.io_priority);
+    // Without flushes a done record may outlive the file data after power loss, so under
+    // Durability::none done records are neither written nor trusted (partial records still are)
+    const bool trust_done = options.durability != Durability::none;
+    struct FilePlan { bool need = true; bool stamped = false; bool from_journal = false; std::string key; detail::FileStamp stamp; };
+    auto plan_file = [&](const fs::path &src_path, const fs::path &rel, const fs::path &dst_path) {
+        FilePlan fp;
+        fp.stamped = journal && detail::stamp_of(src_path, fp.stamp);
+        if(fp.stamped) {
+            fp.key = detail::journal_key(rel);
+            // Completed by an interrupted earlier run and source unchanged since: trust it, no hashing
+            std::error_code ec; auto dst_size = fs::file_size(dst_path, ec);
+            if(trust_done && !ec && dst_size == fp.stamp.size && journal->is_done(fp.key, fp.stamp)) { fp.need = false; fp.from_journal = true; return fp; }
+        }
+        fp.need = should_copy_file(src_path, dst_path, &throttle);
+        if(!fp.need && fp.stamped && trust_done) journal->record_done(fp.key, fp.stamp);
+        return fp;
+    };
+    auto copy_file_force = [&](const fs::path &src, const fs::path &dst, const FilePlan &fp, bool &resumed) -> bool {
+        fs::path tmp = detail::temp_path_for(dst);
+        detail::CopyPlan plan; plan.throttle = &throttle;
+        if(fp.stamped) {
+            std::uint64_t offset = journal->partial_offset(fp.key, fp.stamp);
+            if(offset > 0 && detail::resume_point_valid(src, tmp, offset)) { plan.resume_from = offset; resumed = true; }
+            if(options.checkpoint_bytes > 0 && fp.stamp.size > options.checkpoint_bytes) {
+                plan.checkpoint_bytes = options.checkpoint_bytes;
+                plan.on_checkpoint = [&](std::uint64_t off){ journal->record_partial(fp.key, fp.stamp, off); };
+            }
+        }
+        return detail::copy_to_temp(src, tmp, plan) && publisher.publish(tmp, dst, fp.key, fp.stamped ? &fp.stamp : nullptr);
+    };
+    // Renames deferred by Durability::batch are only final after finish(); undo their copy count on failure.
+    // A run without errors has nothing left to resume, so the journal is dropped.
+    auto finish_publish = [&](){
+        if(auto failed = publisher.finish()) { stats.files_copied -= failed; stats.errors += failed; }
+        if(journal) { if(stats.errors == errors_before) journal->remove(); else journal->sync(); }
+    };
     // Phase 1: create directories
+    std::set<fs::path> new_dir_parents;
     for(auto const &src_path : dirs) {
         auto rel = fs::relative(src_path, source);
         fs::path dst_path = dest / rel;
@@ -155,59 +229,69 @@ void sync_directory(const fs::path &source, const fs::path &dest, SyncStats &sta
             } else {
                 std::error_code ec; fs::create_directories(dst_path, ec);
                 if(!ec) {
-                    ++stats.dirs_created; if(options.verbose) std::cout << C_MKDIR << "mkdir" << C_RESET << " " << rel.generic_string() << "\n";
+                    ++stats.dirs_created; new_dir_parents.insert(dst_path.parent_path());
+                    if(options.verbose) std::cout << C_MKDIR << "mkdir" << C_RESET << " " << rel.generic_string() << "\n";
                 } else { std::cerr << "WARN: cannot create dir "<<dst_path<<": "<<ec.message()<<"\n"; ++stats.errors; }
             }
         }
     }
+    // Persist the new directory entries (and dest itself, possibly created by the caller) so that
+    // files published below cannot vanish with their directory after a crash
+    if(!dry_run && options.durability != Durability::none) {
+        new_dir_parents.insert(dest.parent_path());
+        for(auto const &d : new_dir_parents) detail::flush_dir(d);
+    }
     // Phase 2: files (maybe parallel)
     unsigned thread_count = options.threads == 0 ? std::thread::hardware_concurrency() : options.threads;
     if(thread_count <= 1 || files.size() < 8) {
         // sequential fallback
         for(auto const &src_path : files) {
             auto rel = fs::relative(src_path, source); fs::path dst_path = dest / rel; std::error_code ec;
-            bool need = should_copy_file(src_path, dst_path);
-            if(need) {
+            FilePlan fp = plan_file(src_path, rel, dst_path); bool resumed = false;
+            if(fp.need) {
                 if(dry_run) { ++stats.files_copied; if(options.verbose) std::cout << C_DRY << "DRY-RUN:" << C_RESET << " " << C_COPY << "copy" << C_RESET << " "<<rel.generic_string()<<"\n"; }
                 else {
                     fs::create_directories(dst_path.parent_path(), ec); ec.clear();
-                    if(copy_file_force(src_path, dst_path)) { ++stats.files_copied; if(options.verbose) std::cout << C_COPY << "copy" << C_RESET << " "<<rel.generic_string()<<"\n"; }
+                    if(copy_file_force(src_path, dst_path, fp, resumed)) { ++stats.files_copied; stats.files_resumed += resumed; if(options.verbose) std::cout << C_COPY << "copy" << C_RESET << (resumed?" (resumed) ":" ")<<rel.generic_string()<<"\n"; }
                     else { std::cerr << "WARN: copy failed "<<src_path<<" -> "<<dst_path<<" (fallback)\n"; ++stats.errors; }
                 }
             } else {
-                ++stats.files_skipped; if(options.verbose) { if(dry_run) std::cout << C_DRY << "DRY-RUN:" << C_RESET << " " << C_SKIP << "skip" << C_RESET << " (identical) "<<rel.generic_string()<<"\n"; else std::cout << C_SKIP << "skip" << C_RESET << " "<<rel.generic_string()<<"\n"; }
+                ++stats.files_skipped; if(options.verbose) { if(dry_run) std::cout << C_DRY << "DRY-RUN:" << C_RESET << " " << C_SKIP << "skip" << C_RESET << " (identical) "<<rel.generic_string()<<"\n"; else std::cout << C_SKIP << "skip" << C_RESET << (fp.from_journal?" (journal) ":" ")<<rel.generic_string()<<"\n"; }
             }
         }
+        finish_publish();
         return;
     }
     thread_count = std::min<unsigned>(thread_count, static_cast<unsigned>(files.size()));
     std::mutex out_mutex;
     std::vector<std::thread> workers; workers.reserve(thread_count);
-    std::vector<std::uintmax_t> copied(thread_count,0), skipped(thread_count,0);
+    std::vector<std::uintmax_t> copied(thread_count,0), skipped(thread_count,0), failed(thread_count,0), resumed_n(thread_count,0);
     auto worker = [&](unsigned idx){
+        detail::ScopedIoPriority worker_priority(options.io_priority); // Windows background mode is per-thread
         size_t chunk = (files.size() + thread_count - 1)/thread_count;
         size_t begin = idx * chunk;
         size_t end = std::min(files.size(), begin + chunk);
         for(size_t i=begin; i<end; ++i) {
             const auto &src_path = files[i];
             auto rel = fs::relative(src_path, source); fs::path dst_path = dest / rel; std::error_code ec;
-            bool need = should_copy_file(src_path, dst_path);
-            if(need) {
+            FilePlan fp = plan_file(src_path, rel, dst_path); bool resumed = false;
+            if(fp.need) {
                 if(dry_run) {
                     ++copied[idx]; if(options.verbose){ std::lock_guard<std::mutex> lk(out_mutex); std::cout << C_DRY << "DRY-RUN:" << C_RESET << " " << C_COPY << "copy" << C_RESET << " "<<rel.generic_string()<<"\n"; }
                 } else {
                     fs::create_directories(dst_path.parent_path(), ec); ec.clear();
-                    if(copy_file_force(src_path, dst_path)) { ++copied[idx]; if(options.verbose){ std::lock_guard<std::mutex> lk(out_mutex); std::cout << C_COPY << "copy" << C_RESET << " "<<rel.generic_string()<<"\n"; } }
-                    else { std::lock_guard<std::mutex> lk(out_mutex); std::cerr << "WARN: copy failed "<<src_path<<" -> "<<dst_path<<" (fallback)\n"; }
+                    if(copy_file_force(src_path, dst_path, fp, resumed)) { ++copied[idx]; resumed_n[idx] += resumed; if(options.verbose){ std::lock_guard<std::mutex> lk(out_mutex); std::cout << C_COPY << "copy" << C_RESET << (resumed?" (resumed) ":" ")<<rel.generic_string()<<"\n"; } }
+                    else { ++failed[idx]; std::lock_guard<std::mutex> lk(out_mutex); std::cerr << "WARN: copy failed "<<src_path<<" -> "<<dst_path<<" (fallback)\n"; }
                 }
             } else {
-                ++skipped[idx]; if(options.verbose){ std::lock_guard<std::mutex> lk(out_mutex); if(dry_run) std::cout << C_DRY << "DRY-RUN:" << C_RESET << " " << C_SKIP << "skip" << C_RESET << " (identical) "<<rel.generic_string()<<"\n"; else std::cout << C_SKIP << "skip" << C_RESET << " "<<rel.generic_string()<<"\n"; }
+                ++skipped[idx]; if(options.verbose){ std::lock_guard<std::mutex> lk(out_mutex); if(dry_run) std::cout << C_DRY << "DRY-RUN:" << C_RESET << " " << C_SKIP << "skip" << C_RESET << " (identical) "<<rel.generic_string()<<"\n"; else std::cout << C_SKIP << "skip" << C_RESET << (fp.from_journal?" (journal) ":" ")<<rel.generic_string()<<"\n"; }
             }
         }
     };
     for(unsigned t=0;t<thread_count;++t) workers.emplace_back(worker,t);
     for(auto &th: workers) th.join();
-    for(unsigned t=0;t<thread_count;++t){ stats.files_copied += copied[t]; stats.files_skipped += skipped[t]; }
+    for(unsigned t=0;t<thread_count;++t){ stats.files_copied += copied[t]; stats.files_skipped += skipped[t]; stats.errors += failed[t]; stats.files_resumed += resumed_n[t]; }
+    finish_publish();
 }
 
 // Backward compatibility overload
@@ -215,6 +299,64 @@ void sync_directory(const fs::path &source, const fs::path &dest, SyncStats &sta
     SyncOptions opts; opts.dry_run = dry_run; sync_directory(source, dest, stats, opts);
 }
 
+bool copy_file_atomic(const fs::path &src, const fs::path &dst, const SyncOptions &options) {
+    // A single file gains nothing from batching; treat batch as strict.
+    detail::PublishQueue publisher(options.durability == Durability::batch ? Durability::strict : options.durability);
+    detail::IoThrottle throttle(options);
+    detail::ScopedIoPriority io_priority(options.io_priority);
+    detail::CopyPlan plan; plan.throttle = &throttle;
+    fs::path tmp = detail::temp_path_for(dst);
+    return detail::copy_to_temp(src, tmp, plan) && publisher.publish(tmp, dst);
+}
+
+bool copy_file_atomic(const fs::path &src, const fs::path &dst, Durability durability) {
+    SyncOptions opts; opts.durability = durability; return copy_file_atomic(src, dst, opts);
+}
+
+bool parse_durability(std::string_view v, Durability &out) {
+    if(v == "none") { out = Durability::none; return true; }
+    if(v == "batch") { out = Durability::batch; return true; }
+    if(v == "strict") { out = Durability::strict; return true; }
+    return false;
+}
+
+const char* to_string(Durability d) {
+    switch(d) {
+    case Durability::none: return "none";
+    case Durability::batch: return "batch";
+    case Durability::strict: return "strict";
+    }
+    return "?";
+}
+
+bool parse_rate(std::string_view v, std::uint64_t &out) {
+    if(v.ends_with("/s")) v.remove_suffix(2);
+    if(v.ends_with('B') || v.ends_with('b')) v.remove_suffix(1);
+    std::uint64_t mult = 1;
+    if(!v.empty()) {
+        switch(v.back()) {
+        case 'K': case 'k': mult = 1ULL << 10; break;
+        case 'M': case 'm': mult = 1ULL << 20; break;
+        case 'G': case 'g': mult = 1ULL << 30; break;
+        default: break;
+        }
+        if(mult != 1) v.remove_suffix(1);
+    }
+    std::uint64_t value = 0;
+    auto [end, err] = std::from_chars(v.data(), v.data() + v.size(), value);
+    if(v.empty() || err != std::errc() || end != v.data() + v.size()) return false;
+    if(value > std::numeric_limits<std::uint64_t>::max() / mult) return false;
+    out = value * mult;
+    return true;
+}
+
+bool parse_io_priority(std::string_view v, IoPriority &out) {
+    if(v == "normal") { out = IoPriority::normal; return true; }
+    if(v == "best-effort" || v == "best_effort") { out = IoPriority::best_effort; return true; }
+    if(v == "idle") { out = IoPriority::idle; return true; }
+    return false;
+}
+
 std::string strip_quotes(std::string_view v) {
     if(v.size()>=2) {
         char a=v.front(), b=v.back();
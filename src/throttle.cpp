@@ -0,0 +1,89 @@
+#include "throttle.hpp"
+#include <algorithm>
+#include <thread>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace syncbone::detail {
+using namespace std::chrono;
+
+TokenBucket::TokenBucket(std::uint64_t rate_per_sec)
+    : rate_(static_cast<double>(rate_per_sec)), capacity_(rate_ / 10.0), tokens_(capacity_), last_(steady_clock::now()) {}
+
+nanoseconds TokenBucket::reserve(double n) {
+    if(rate_ <= 0) return nanoseconds{0};
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto now = steady_clock::now();
+    tokens_ = std::min(capacity_, tokens_ + duration<double>(now - last_).count() * rate_);
+    last_ = now;
+    tokens_ -= n; // may go negative: the debt is paid by the caller sleeping
+    if(tokens_ >= 0) return nanoseconds{0};
+    return duration_cast<nanoseconds>(duration<double>(-tokens_ / rate_));
+}
+
+IoThrottle::IoThrottle(const SyncOptions &options)
+    : read_(options.read_bps), write_(options.write_bps), iops_(options.iops),
+      target_(milliseconds(options.latency_target_ms)),
+      active_(read_.limited() || write_.limited() || iops_.limited() || options.latency_target_ms > 0) {}
+
+void IoThrottle::wait(TokenBucket &bytes_bucket, std::size_t bytes) {
+    // Both reservations are taken up front, so sleeping for the longer one satisfies both
+    auto delay = std::max(bytes_bucket.reserve(static_cast<double>(bytes)), iops_.reserve(1));
+    delay += nanoseconds(backoff_ns_.load(std::memory_order_relaxed));
+    if(delay.count() > 0) std::this_thread::sleep_for(delay);
+}
+
+void IoThrottle::after_read(std::size_t bytes) { wait(read_, bytes); }
+void IoThrottle::before_write(std::size_t bytes) { wait(write_, bytes); }
+
+void IoThrottle::record_latency(nanoseconds sample) {
+    if(target_.count() == 0) return;
+    // EWMA (alpha 1/8); concurrent updates may drop a sample, which is harmless here
+    std::int64_t ewma = ewma_ns_.load(std::memory_order_relaxed);
+    ewma += (sample.count() - ewma) / 8;
+    ewma_ns_.store(ewma, std::memory_order_relaxed);
+    std::int64_t backoff = backoff_ns_.load(std::memory_order_relaxed);
+    constexpr std::int64_t step = duration_cast<nanoseconds>(milliseconds(1)).count();
+    constexpr std::int64_t cap = duration_cast<nanoseconds>(milliseconds(250)).count();
+    if(ewma > target_.count()) backoff = std::min(cap, backoff * 2 + step);
+    else backoff = backoff < 10000 ? 0 : backoff - backoff / 8;
+    backoff_ns_.store(backoff, std::memory_order_relaxed);
+}
+
+#if defined(__linux__)
+// From linux/ioprio.h (not always installed with libc headers)
+static constexpr int IOPRIO_WHO_PROCESS = 1;
+static constexpr int IOPRIO_CLASS_SHIFT = 13;
+static constexpr int IOPRIO_CLASS_BE = 2;
+static constexpr int IOPRIO_CLASS_IDLE = 3;
+#endif
+
+ScopedIoPriority::ScopedIoPriority(IoPriority prio) {
+    if(prio == IoPriority::normal) return;
+#if defined(__linux__)
+    // who=PROCESS with pid 0 targets the calling thread; threads spawned later inherit it
+    int value = prio == IoPriority::idle ? (IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT)
+                                         : (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 7;
+    int old = static_cast<int>(::syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0));
+    if(old >= 0 && ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, value) == 0) previous_ = old;
+#elif defined(_WIN32)
+    // Background mode lowers both CPU and I/O priority; there is no separate best-effort class
+    if(prio == IoPriority::idle && SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN)) previous_ = 0;
+#endif
+}
+
+ScopedIoPriority::~ScopedIoPriority() {
+    if(previous_ < 0) return;
+#if defined(__linux__)
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, previous_);
+#elif defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+#endif
+}
+
+} // namespace syncbone::detail
@@ -0,0 +1,72 @@
+/**
+ * \file throttle.hpp
+ * \brief Internal I/O rate limiting (token buckets), latency backoff and I/O priority.
+ */
+#pragma once
+#include "syncbone/sync.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace syncbone::detail {
+
+/**
+ * \brief Thread-safe token bucket; callers reserve tokens and sleep off any debt.
+ * \details Burst capacity is 100 ms worth of tokens. A rate of 0 means unlimited.
+ */
+class TokenBucket {
+public:
+    explicit TokenBucket(std::uint64_t rate_per_sec);
+    /** \brief Take n tokens, returning how long the caller has to wait before using them. */
+    std::chrono::nanoseconds reserve(double n);
+    bool limited() const { return rate_ > 0; }
+private:
+    std::mutex mutex_;
+    double rate_, capacity_, tokens_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+/**
+ * \brief Shared throttle for all workers of one sync run.
+ * \details Call after_read() with the bytes each read actually returned (the size is not known
+ * up front for short files) and before_write() ahead of each chunk write. When
+ * SyncOptions::latency_target_ms is set, copies flush their written data to the device at
+ * least every latency_probe_bytes and at the end of each file, and feed the flush duration
+ * to record_latency() (buffered read/write calls mostly hit the page cache and would not
+ * show device latency). An extra per-operation delay grows while the smoothed flush latency
+ * stays above target and decays once it recovers.
+ */
+class IoThrottle {
+public:
+    explicit IoThrottle(const SyncOptions &options);
+    /** \brief True if any limit or latency target is configured. */
+    bool active() const { return active_; }
+    /** \brief True if copies should probe device latency (see latency_probe_bytes). */
+    bool probes_latency() const { return target_.count() > 0; }
+    static constexpr std::uint64_t latency_probe_bytes = 4ULL << 20;
+    /** \brief Current adaptive delay added to every operation. */
+    std::chrono::nanoseconds backoff() const { return std::chrono::nanoseconds(backoff_ns_.load(std::memory_order_relaxed)); }
+    /** \brief Charge a completed read of bytes; sleeps off any debt so the next read is paced. */
+    void after_read(std::size_t bytes);
+    void before_write(std::size_t bytes);
+    void record_latency(std::chrono::nanoseconds sample);
+private:
+    void wait(TokenBucket &bytes_bucket, std::size_t bytes);
+    TokenBucket read_, write_, iops_;
+    std::chrono::nanoseconds target_;
+    std::atomic<std::int64_t> ewma_ns_{0}, backoff_ns_{0};
+    bool active_;
+};
+
+/** \brief Applies an IoPriority to the calling thread and restores the previous one on destruction. */
+class ScopedIoPriority {
+public:
+    explicit ScopedIoPriority(IoPriority prio);
+    ~ScopedIoPriority();
+    ScopedIoPriority(const ScopedIoPriority&) = delete;
+    ScopedIoPriority& operator=(const ScopedIoPriority&) = delete;
+private:
+    int previous_ = -1;
+};
+
+} // namespace syncbone::detail
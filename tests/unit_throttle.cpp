@@ -0,0 +1,167 @@
+// unit_throttle.cpp - I/O rate limits, priority class and limit parsing
+
+#include "syncbone/sync.hpp"
+#include "throttle.hpp"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+using namespace syncbone;
+namespace fs = std::filesystem;
+
+static fs::path make_temp_dir(const char* name){
+    fs::path p = fs::path("unit_tmp")/name;
+    fs::remove_all(p); fs::create_directories(p); return p;
+}
+static void write_file(const fs::path &p, const std::string &c){ fs::create_directories(p.parent_path()); std::ofstream o(p, std::ios::binary); o<<c; }
+static std::string read_file(const fs::path &p){ std::ifstream i(p, std::ios::binary); return std::string((std::istreambuf_iterator<char>(i)),{}); }
+
+static double timed_sync(const fs::path &src, const fs::path &dst, const SyncOptions &opt, SyncStats &st){
+    auto t0 = std::chrono::steady_clock::now();
+    sync_directory(src, dst, st, opt);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void test_parse(){
+    std::uint64_t r = 0;
+    assert(parse_rate("1000", r) && r == 1000);
+    assert(parse_rate("512K", r) && r == 512*1024);
+    assert(parse_rate("20MB/s", r) && r == 20ULL*1024*1024);
+    assert(parse_rate("1g", r) && r == 1ULL<<30);
+    assert(!parse_rate("", r) && !parse_rate("M", r) && !parse_rate("-5", r) && !parse_rate("1.5M", r));
+    assert(!parse_rate("999999999999G", r) && !parse_rate("99999999999999999999", r)); // overflow
+    assert(parse_rate("18446744073709551615", r) && r == std::numeric_limits<std::uint64_t>::max());
+    IoPriority p = IoPriority::normal;
+    assert(parse_io_priority("idle", p) && p == IoPriority::idle);
+    assert(parse_io_priority("best-effort", p) && p == IoPriority::best_effort);
+    assert(!parse_io_priority("realtime", p) && p == IoPriority::best_effort);
+}
+
+// 8 x 64 KiB = 512 KiB at 1 MiB/s write limit must take about half a second, even with 4 workers
+static void test_write_limit_shared_across_threads(){
+    auto src = make_temp_dir("thr_src");
+    std::string blob(64*1024, 'x');
+    for(int i=0;i<8;++i) write_file(src/("f"+std::to_string(i)+".bin"), blob);
+    auto dst = make_temp_dir("thr_dst");
+    SyncOptions opt; opt.threads = 4; opt.write_bps = 1024*1024;
+    SyncStats st; double sec = timed_sync(src, dst, opt, st);
+    assert(st.files_copied == 8 && st.errors == 0);
+    assert(sec >= 0.3);
+    assert(read_file(dst/"f7.bin") == blob);
+}
+
+// Resync only reads (hashing); the read limit applies there as well
+static void test_read_limit_on_hashing(){
+    auto src = make_temp_dir("thr_hash_src");
+    std::string blob(128*1024, 'y');
+    write_file(src/"a.bin", blob); write_file(src/"b.bin", blob);
+    auto dst = make_temp_dir("thr_hash_dst");
+    SyncStats st1; sync_directory(src, dst, st1, SyncOptions{});
+    SyncOptions opt; opt.read_bps = 1024*1024; // 4 x 128 KiB hashed -> ~0.4 s
+    SyncStats st2; double sec = timed_sync(src, dst, opt, st2);
+    assert(st2.files_skipped == 2 && st2.files_copied == 0);
+    assert(sec >= 0.25 && sec < 2.0);
+}
+
+// Reads are charged by bytes actually read: tiny files must not cost a full 256 KiB chunk each
+static void test_read_limit_small_files(){
+    auto src = make_temp_dir("thr_small_src");
+    for(int i=0;i<20;++i) write_file(src/("f"+std::to_string(i)+".txt"), "12345");
+    auto dst = make_temp_dir("thr_small_dst");
+    SyncOptions opt; opt.read_bps = 1024*1024;
+    SyncStats st1; double first = timed_sync(src, dst, opt, st1);
+    assert(st1.files_copied == 20 && first < 1.0);
+    SyncStats st2; double resync = timed_sync(src, dst, opt, st2); // hashes 40 five-byte files
+    assert(st2.files_skipped == 20 && resync < 1.0);
+}
+
+static void test_priority_and_latency_target_do_not_change_results(){
+    auto src = make_temp_dir("thr_prio_src");
+    write_file(src/"d"/"x.txt","XYZ");
+    auto dst = make_temp_dir("thr_prio_dst");
+    SyncOptions opt; opt.io_priority = IoPriority::idle; opt.latency_target_ms = 50; opt.iops = 1000;
+    SyncStats st; sync_directory(src, dst, st, opt);
+    assert(st.files_copied == 1 && st.errors == 0);
+    assert(read_file(dst/"d"/"x.txt") == "XYZ");
+}
+
+// Throttled copies go through the chunked path; the source mode must survive it
+static void test_throttled_copy_keeps_permissions(){
+    auto src = make_temp_dir("thr_perm_src");
+    write_file(src/"run.sh", "#!/bin/sh\necho hi\n");
+    const auto mode = fs::perms::owner_all | fs::perms::group_read | fs::perms::group_exec | fs::perms::others_read | fs::perms::others_exec;
+    fs::permissions(src/"run.sh", mode, fs::perm_options::replace);
+    auto dst = make_temp_dir("thr_perm_dst");
+    SyncOptions opt; opt.write_bps = 10*1024*1024;
+    SyncStats st; sync_directory(src, dst, st, opt);
+    assert(st.files_copied == 1 && st.errors == 0);
+    assert(fs::status(dst/"run.sh").permissions() == fs::status(src/"run.sh").permissions());
+}
+
+// Slow flush samples must engage the backoff delay, fast ones must release it again
+static void test_latency_backoff_engages(){
+    using namespace std::chrono;
+    SyncOptions opt; opt.latency_target_ms = 5;
+    detail::IoThrottle throttle(opt);
+    assert(throttle.active() && throttle.probes_latency());
+    assert(throttle.backoff().count() == 0);
+    for(int i=0;i<8;++i) throttle.record_latency(milliseconds(50));
+    auto delay = throttle.backoff();
+    assert(delay >= milliseconds(10));
+    auto t0 = steady_clock::now();
+    throttle.before_write(4096);
+    assert(steady_clock::now() - t0 >= delay);
+    for(int i=0;i<200;++i) throttle.record_latency(microseconds(100));
+    assert(throttle.backoff().count() == 0);
+    // Without a target latency samples are ignored
+    detail::IoThrottle plain(SyncOptions{});
+    assert(!plain.probes_latency());
+    plain.record_latency(seconds(1));
+    assert(plain.backoff().count() == 0);
+}
+
+// The single-file entry point must honor the same limits as directory syncs
+static void test_single_file_copy_is_throttled(){
+    auto d = make_temp_dir("thr_single");
+    std::string blob(512*1024, 'z');
+    write_file(d/"big.bin", blob);
+    SyncOptions opt; opt.write_bps = 1024*1024; opt.io_priority = IoPriority::best_effort;
+    auto t0 = std::chrono::steady_clock::now();
+    assert(copy_file_atomic(d/"big.bin", d/"copy.bin", opt));
+    assert(std::chrono::steady_clock::now() - t0 >= std::chrono::milliseconds(300));
+    assert(read_file(d/"copy.bin") == blob);
+}
+
+// A leftover temp from a killed run may already be read-only (source mode applied); it must be replaced
+static void test_throttled_copy_replaces_readonly_stale_temp(){
+    auto src = make_temp_dir("thr_ro_src");
+    write_file(src/"ro.txt", "fresh");
+    fs::permissions(src/"ro.txt", fs::perms::owner_read | fs::perms::group_read | fs::perms::others_read, fs::perm_options::replace);
+    auto dst = make_temp_dir("thr_ro_dst");
+    write_file(dst/".ro.txt.sbtmp", "stale");
+    fs::permissions(dst/".ro.txt.sbtmp", fs::perms::owner_read | fs::perms::group_read | fs::perms::others_read, fs::perm_options::replace);
+    SyncOptions opt; opt.write_bps = 10*1024*1024;
+    SyncStats st; sync_directory(src, dst, st, opt);
+    assert(st.files_copied == 1 && st.errors == 0);
+    assert(read_file(dst/"ro.txt") == "fresh");
+    assert(!fs::exists(dst/".ro.txt.sbtmp"));
+    fs::permissions(src/"ro.txt", fs::perms::owner_write, fs::perm_options::add);
+    fs::permissions(dst/"ro.txt", fs::perms::owner_write, fs::perm_options::add);
+}
+
+int main(){
+    test_parse();
+    test_write_limit_shared_across_threads();
+    test_read_limit_on_hashing();
+    test_read_limit_small_files();
+    test_priority_and_latency_target_do_not_change_results();
+    test_throttled_copy_keeps_permissions();
+    test_latency_backoff_engages();
+    test_single_file_copy_is_throttled();
+    test_throttled_copy_replaces_readonly_stale_temp();
+    std::cout << "Throttle tests passed" << std::endl;
+    return 0;
+}